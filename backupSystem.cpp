@@ -1,21 +1,39 @@
 #include "backupSystem.h"
+#include "changeJournal.h"
 #include <ctime>
 #include <algorithm>
+#include <map>
+#include <cerrno>
 
-BackupSystem::BackupSystem(bool encrypt, unsigned char key) 
-    : encryptEnabled(encrypt), encryptionKey(key), outputPath("./") {
+const char* BackupSystem::EXTENT_MANIFEST = ".backup_extents";
+
+BackupSystem::BackupSystem(bool encrypt, unsigned char key, int threads, bool pinThreads,
+                           const std::vector<int>& cpus) 
+    : encryptEnabled(encrypt), encryptionKey(key), outputPath("./"), pool(threads, pinThreads, cpus) {
     std::cout << "Sistema de Backup inicializado" << std::endl;
     std::cout << "Encriptación: " << (encryptEnabled ? "ACTIVADA" : "DESACTIVADA") << std::endl;
-    std::cout << "Paralelismo OpenMP: " << omp_get_max_threads() << " hilos disponibles" << std::endl;
+    std::cout << "Paralelismo: pool de " << pool.size() << " hilos"
+              << (pool.pinned() ? " fijados a CPU" : "") << std::endl;
 }
 
 void BackupSystem::scanDirectory(const std::string& dirPath, const std::string& basePath) {
+    // Cada carpeta es una tarea del pool; las subcarpetas generan nuevas tareas
+    ThreadPool::TaskGroup group;
+    pool.spawn(group, [this, dirPath, basePath, &group] {
+        scanDirectoryTask(dirPath, basePath, group);
+    });
+    pool.wait(group);
+}
+
+void BackupSystem::scanDirectoryTask(const std::string& dirPath, const std::string& basePath,
+                                     ThreadPool::TaskGroup& group) {
     DIR* dir = opendir(dirPath.c_str());
     if (!dir) {
         std::cerr << "No se pudo abrir directorio: " << dirPath << std::endl;
         return;
     }
     
+    std::vector<FileInfo> localFiles;
     struct dirent* entry;
     while ((entry = readdir(dir)) != nullptr) {
         if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
@@ -25,22 +43,34 @@ void BackupSystem::scanDirectory(const std::string& dirPath, const std::string&
         std::string fullPath = dirPath + "/" + entry->d_name;
         std::string relativePath = fullPath.substr(basePath.length() + 1);
         
-        if (isDirectory(fullPath)) {
-            // Recursivamente escanear subdirectorios
-            scanDirectory(fullPath, basePath);
+        struct stat fileStat;
+        if (stat(fullPath.c_str(), &fileStat) != 0) {
+            continue;
+        }
+        
+        if (S_ISDIR(fileStat.st_mode)) {
+            // Recursivamente escanear subdirectorios en paralelo
+            pool.spawn(group, [this, fullPath, basePath, &group] {
+                scanDirectoryTask(fullPath, basePath, group);
+            });
         } else {
             // Es un archivo, añadir a la lista
-            struct stat fileStat;
-            if (stat(fullPath.c_str(), &fileStat) == 0) {
-                FileInfo info;
-                info.fullPath = fullPath;
-                info.relativePath = relativePath;
-                info.size = fileStat.st_size;
-                fileList.push_back(info);
-            }
+            FileInfo info;
+            info.fullPath = fullPath;
+            info.relativePath = relativePath;
+            info.size = fileStat.st_size;
+            info.allocatedSize = (size_t)fileStat.st_blocks * 512;
+            info.device = fileStat.st_dev;
+            info.inode = fileStat.st_ino;
+            info.linkCount = fileStat.st_nlink;
+            info.linkTarget = -1;
+            localFiles.push_back(info);
         }
     }
     closedir(dir);
+    
+    std::lock_guard<std::mutex> lock(fileListMutex);
+    fileList.insert(fileList.end(), localFiles.begin(), localFiles.end());
 }
 
 void BackupSystem::scanFolder(const std::string& folderPath) {
@@ -54,18 +84,269 @@ void BackupSystem::scanFolder(const std::string& folderPath) {
         return;
     }
     
-    // Escanear recursivamente
-    scanDirectory(folderPath, folderPath);
+    // Con diario válido solo se revisan las rutas cambiadas; si no, escanear recursivamente
+    bool indexUpToDate = false;
+    if (journalPath.empty() || !scanFromJournal(folderPath, indexUpToDate)) {
+        scanDirectory(folderPath, folderPath);
+        
+        // El escaneo paralelo no garantiza orden: ordenar para resultados reproducibles
+        std::sort(fileList.begin(), fileList.end(), [](const FileInfo& a, const FileInfo& b) {
+            return a.relativePath < b.relativePath;
+        });
+    }
+    resolveHardLinks();
+    
+    if (!journalPath.empty()) {
+        ChangeJournal journal(journalPath);
+        if (!indexUpToDate) {
+            saveIndex(journal.indexPath(), folderPath);
+        }
+        journal.commit();
+    }
     
     std::cout << "Archivos encontrados: " << fileList.size() << std::endl;
     
-    // Calcular tamaño total
+    // Calcular tamaño total (los enlaces duros solo cuentan una vez)
     size_t totalSize = 0;
+    size_t diskSize = 0;
+    int sparseFiles = 0;
+    int hardLinks = 0;
     for (const auto& file : fileList) {
+        if (file.linkTarget >= 0) {
+            hardLinks++;
+            continue;
+        }
         totalSize += file.size;
+        diskSize += std::min(file.size, file.allocatedSize);
+        if (file.allocatedSize < file.size) {
+            sparseFiles++;
+        }
     }
     
     std::cout << "Tamaño total: " << totalSize << " bytes" << std::endl;
+    std::cout << "Datos a leer: " << diskSize << " bytes" << std::endl;
+    std::cout << "Archivos dispersos: " << sparseFiles << std::endl;
+    std::cout << "Enlaces duros: " << hardLinks << std::endl;
+}
+
+bool BackupSystem::scanFromJournal(const std::string& folderPath, bool& indexUpToDate) {
+    ChangeJournal journal(journalPath);
+    std::vector<std::string> changedPaths;
+    
+    if (!journal.consume(folderPath, changedPaths)) {
+        std::cout << "Diario no disponible o desbordado: escaneo completo" << std::endl;
+        return false;
+    }
+    if (!loadIndex(journal.indexPath(), folderPath)) {
+        std::cout << "Índice no encontrado: escaneo completo" << std::endl;
+        fileList.clear();
+        return false;
+    }
+    
+    std::cout << "Usando diario de cambios: " << changedPaths.size() << " rutas modificadas" << std::endl;
+    
+    // Sin cambios el índice cargado ya es la lista de archivos: no reescribirlo
+    if (changedPaths.empty()) {
+        indexUpToDate = true;
+        return true;
+    }
+    
+    // changedPaths está ordenada: una ruta dentro de otra cambiada ya queda cubierta
+    // al descartar y reescanear el subárbol de su antecesora
+    auto coveredByAncestor = [&changedPaths](const std::string& path) {
+        for (size_t slash = path.find('/'); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+            if (std::binary_search(changedPaths.begin(), changedPaths.end(), path.substr(0, slash))) {
+                return true;
+            }
+        }
+        return false;
+    };
+    
+    // El índice está ordenado por ruta relativa: localizar por búsqueda binaria los
+    // tramos que invalida cada cambio y fusionar después en una sola pasada
+    std::vector<FileInfo> indexed;
+    indexed.swap(fileList);
+    auto position = [&indexed](const std::string& path) {
+        return (size_t)(std::lower_bound(indexed.begin(), indexed.end(), path,
+                                         [](const FileInfo& info, const std::string& value) {
+                                             return info.relativePath < value;
+                                         }) - indexed.begin());
+    };
+    
+    std::vector<std::pair<size_t, size_t>> removed;   // Tramos [inicio, fin) del índice
+    std::vector<FileInfo> changedFiles;
+    ThreadPool::TaskGroup group;
+    
+    for (const auto& relativePath : changedPaths) {
+        if (coveredByAncestor(relativePath)) {
+            continue;
+        }
+        
+        // Descartar la ruta y todo lo que colgaba de ella ('0' sigue a '/' en ASCII)
+        size_t first = position(relativePath);
+        if (first < indexed.size() && indexed[first].relativePath == relativePath) {
+            removed.push_back(std::make_pair(first, first + 1));
+        }
+        removed.push_back(std::make_pair(position(relativePath + "/"), position(relativePath + "0")));
+        
+        std::string fullPath = folderPath + "/" + relativePath;
+        struct stat fileStat;
+        if (stat(fullPath.c_str(), &fileStat) != 0) {
+            continue; // Eliminado
+        }
+        
+        if (S_ISDIR(fileStat.st_mode)) {
+            // Todas las carpetas cambiadas se escanean en el mismo grupo del pool
+            pool.spawn(group, [this, fullPath, folderPath, &group] {
+                scanDirectoryTask(fullPath, folderPath, group);
+            });
+        } else {
+            FileInfo info;
+            info.fullPath = fullPath;
+            info.relativePath = relativePath;
+            info.size = fileStat.st_size;
+            info.allocatedSize = (size_t)fileStat.st_blocks * 512;
+            info.device = fileStat.st_dev;
+            info.inode = fileStat.st_ino;
+            info.linkCount = fileStat.st_nlink;
+            info.linkTarget = -1;
+            changedFiles.push_back(info);
+        }
+    }
+    pool.wait(group);
+    
+    // Archivos nuevos: los de las carpetas reescaneadas más los cambiados sueltos
+    fileList.insert(fileList.end(), changedFiles.begin(), changedFiles.end());
+    std::sort(fileList.begin(), fileList.end(), [](const FileInfo& a, const FileInfo& b) {
+        return a.relativePath < b.relativePath;
+    });
+    std::vector<FileInfo> fresh;
+    fresh.swap(fileList);
+    
+    // Los tramos de subárboles distintos no se solapan: basta ordenarlos por inicio
+    std::sort(removed.begin(), removed.end());
+    
+    fileList.reserve(indexed.size() + fresh.size());
+    size_t nextRemoved = 0;
+    size_t nextFresh = 0;
+    for (size_t i = 0; i < indexed.size(); ) {
+        while (nextRemoved < removed.size() && removed[nextRemoved].second <= i) {
+            nextRemoved++;
+        }
+        if (nextRemoved < removed.size() && removed[nextRemoved].first <= i) {
+            i = removed[nextRemoved].second;
+            continue;
+        }
+        
+        while (nextFresh < fresh.size() && fresh[nextFresh].relativePath < indexed[i].relativePath) {
+            fileList.push_back(std::move(fresh[nextFresh++]));
+        }
+        fileList.push_back(std::move(indexed[i++]));
+    }
+    while (nextFresh < fresh.size()) {
+        fileList.push_back(std::move(fresh[nextFresh++]));
+    }
+    return true;
+}
+
+bool BackupSystem::loadIndex(const std::string& indexFile, const std::string& folderPath) {
+    FILE* file = fopen(indexFile.c_str(), "r");
+    if (!file) {
+        return false;
+    }
+    
+    char* line = nullptr;
+    size_t capacity = 0;
+    ssize_t length;
+    bool valid = false;
+    
+    // Primera línea: "BKI1\t<carpeta>"; el índice solo vale para la misma raíz
+    if ((length = getline(&line, &capacity, file)) != -1) {
+        std::string header(line, length);
+        header.erase(header.find_last_not_of("\n") + 1);
+        valid = (header == "BKI1\t" + folderPath);
+    }
+    
+    // Resto: "tamaño\tasignado\tdispositivo\tinodo\tenlaces\truta"
+    while (valid && (length = getline(&line, &capacity, file)) != -1) {
+        unsigned long long size, allocated, device, inode, links;
+        int pathOffset = 0;
+        if (sscanf(line, "%llu\t%llu\t%llu\t%llu\t%llu\t%n",
+                   &size, &allocated, &device, &inode, &links, &pathOffset) != 5 || pathOffset == 0) {
+            valid = false;
+            break;
+        }
+        
+        FileInfo info;
+        info.relativePath = std::string(line + pathOffset, length - pathOffset);
+        info.relativePath.erase(info.relativePath.find_last_not_of("\n") + 1);
+        
+        // La fusión con el diario depende del orden en que se guardó el índice
+        if (!fileList.empty() && !(fileList.back().relativePath < info.relativePath)) {
+            valid = false;
+            break;
+        }
+        info.fullPath = folderPath + "/" + info.relativePath;
+        info.size = size;
+        info.allocatedSize = allocated;
+        info.device = device;
+        info.inode = inode;
+        info.linkCount = links;
+        info.linkTarget = -1;
+        fileList.push_back(info);
+    }
+    
+    free(line);
+    fclose(file);
+    return valid;
+}
+
+void BackupSystem::saveIndex(const std::string& indexFile, const std::string& folderPath) {
+    std::string tempFile = indexFile + ".tmp";
+    FILE* file = fopen(tempFile.c_str(), "w");
+    if (!file) {
+        std::cerr << "Error al crear índice: " << indexFile << std::endl;
+        return;
+    }
+    
+    fprintf(file, "BKI1\t%s\n", folderPath.c_str());
+    for (const auto& info : fileList) {
+        if (info.relativePath.find('\n') != std::string::npos) {
+            // No representable: sin índice el próximo backup hará escaneo completo
+            fclose(file);
+            unlink(tempFile.c_str());
+            unlink(indexFile.c_str());
+            return;
+        }
+        fprintf(file, "%llu\t%llu\t%llu\t%llu\t%llu\t%s\n",
+                (unsigned long long)info.size, (unsigned long long)info.allocatedSize,
+                (unsigned long long)info.device, (unsigned long long)info.inode,
+                (unsigned long long)info.linkCount, info.relativePath.c_str());
+    }
+    fclose(file);
+    
+    // Reemplazo atómico para no dejar un índice a medias
+    rename(tempFile.c_str(), indexFile.c_str());
+}
+
+void BackupSystem::resolveHardLinks() {
+    // Identificar archivos con el mismo (st_dev, st_ino): solo el primero se copia
+    std::map<std::pair<dev_t, ino_t>, long> firstSeen;
+    
+    for (size_t i = 0; i < fileList.size(); i++) {
+        FileInfo& file = fileList[i];
+        if (file.linkCount < 2) {
+            continue;
+        }
+        
+        auto key = std::make_pair(file.device, file.inode);
+        auto it = firstSeen.find(key);
+        if (it == firstSeen.end()) {
+            firstSeen[key] = (long)i;
+        } else {
+            file.linkTarget = it->second;
+        }
+    }
 }
 
 void BackupSystem::compressFile(const std::string& inputFile, const std::string& outputFile) {
@@ -135,8 +416,7 @@ void BackupSystem::compressFile(const std::string& inputFile, const std::string&
 }
 
 void BackupSystem::encryptBuffer(unsigned char* buffer, size_t size) {
-    // Usar OpenMP para paralelizar la encriptación
-    #pragma omp parallel for
+    // Secuencial: ya corre dentro de una tarea del pool y el compilador lo vectoriza
     for (size_t i = 0; i < size; i++) {
         buffer[i] ^= encryptionKey;
     }
@@ -152,37 +432,97 @@ void BackupSystem::createBackup(const std::string& backupName) {
     std::cout << "Nombre: " << backupName << std::endl;
     std::cout << "Archivos a procesar: " << fileList.size() << std::endl;
     
+    // El manifiesto de extents no puede pisar un archivo real de la carpeta
+    if (encryptEnabled) {
+        for (const auto& file : fileList) {
+            if (file.relativePath == EXTENT_MANIFEST) {
+                std::cerr << "❌ Error: la carpeta contiene '" << EXTENT_MANIFEST
+                          << "', nombre reservado para backups encriptados" << std::endl;
+                return;
+            }
+        }
+    }
+    
     // Crear directorio temporal para el backup
     std::string tempDir = outputPath + "/temp_" + backupName;
     createDirectoryStructure(tempDir);
     
-    // Usar OpenMP para copiar y procesar archivos en paralelo
+    // Usar el pool para copiar y procesar archivos en paralelo
     int totalFiles = fileList.size();
     int processedFiles = 0;
+    std::mutex progressMutex;
     
-    std::cout << "Procesando archivos con OpenMP..." << std::endl;
+    // Extents copiados por archivo; cada tarea solo escribe su propia posición
+    std::vector<ExtentList> fileExtents(totalFiles);
+    std::vector<char> copiedFiles(totalFiles, 0);
     
-    #pragma omp parallel for schedule(dynamic) shared(processedFiles)
-    for (int i = 0; i < totalFiles; i++) {
+    std::cout << "Procesando archivos con " << pool.size() << " hilos..." << std::endl;
+    
+    pool.parallelFor(totalFiles, [&](size_t i) {
         const FileInfo& file = fileList[i];
         
+        // Los enlaces duros se crean después, cuando su original ya existe
+        if (file.linkTarget >= 0) {
+            return;
+        }
+        
         // Crear estructura de directorios en el backup temporal
         std::string outputFile = tempDir + "/" + file.relativePath;
         std::string outputDir = outputFile.substr(0, outputFile.find_last_of('/'));
         
-        #pragma omp critical
         {
+            std::lock_guard<std::mutex> lock(progressMutex);
             createDirectoryStructure(outputDir);
         }
         
         // Copiar y procesar archivo
-        copyAndProcessFile(file.fullPath, outputFile);
+        copyAndProcessFile(file.fullPath, outputFile, fileExtents[i]);
+        copiedFiles[i] = 1;
         
         // Actualizar progreso
-        #pragma omp critical
-        {
-            processedFiles++;
-            showProgress(processedFiles, totalFiles, file.relativePath);
+        std::lock_guard<std::mutex> lock(progressMutex);
+        processedFiles++;
+        showProgress(processedFiles, totalFiles, file.relativePath);
+    });
+    
+    // Enlazar duplicados al archivo ya procesado; tar los guarda como registros de enlace
+    for (int i = 0; i < totalFiles; i++) {
+        const FileInfo& file = fileList[i];
+        if (file.linkTarget < 0) {
+            continue;
+        }
+        
+        std::string outputFile = tempDir + "/" + file.relativePath;
+        std::string targetFile = tempDir + "/" + fileList[file.linkTarget].relativePath;
+        createDirectoryStructure(outputFile.substr(0, outputFile.find_last_of('/')));
+        
+        unlink(outputFile.c_str());
+        if (link(targetFile.c_str(), outputFile.c_str()) != 0) {
+            // Si no se puede enlazar, copiar el contenido como archivo independiente
+            copyAndProcessFile(file.fullPath, outputFile, fileExtents[i]);
+            copiedFiles[i] = 1;
+        }
+        
+        processedFiles++;
+        showProgress(processedFiles, totalFiles, file.relativePath);
+    }
+    
+    // Guardar qué rangos se encriptaron; los enlaces duros comparten los del original
+    if (encryptEnabled) {
+        std::vector<std::string> manifestPaths;
+        std::vector<ExtentList> manifestExtents;
+        for (int i = 0; i < totalFiles; i++) {
+            if (copiedFiles[i]) {
+                manifestPaths.push_back(fileList[i].relativePath);
+                manifestExtents.push_back(fileExtents[i]);
+            }
+        }
+        
+        if (!writeExtentManifest(tempDir + "/" + EXTENT_MANIFEST, manifestPaths, manifestExtents)) {
+            std::cerr << "\n❌ Error escribiendo el manifiesto de extents" << std::endl;
+            std::string cleanCommand = "rm -rf \"" + tempDir + "\"";
+            system(cleanCommand.c_str());
+            return;
         }
     }
     
@@ -190,7 +530,7 @@ void BackupSystem::createBackup(const std::string& backupName) {
     std::string finalBackup = outputPath + "/" + backupName + ".tar.gz";
     std::cout << "\n\nCreando archivo único: " << finalBackup << std::endl;
     
-    std::string tarCommand = "cd \"" + outputPath + "\" && tar -czf \"" + 
+    std::string tarCommand = "cd \"" + outputPath + "\" && tar --sparse -czf \"" + 
                             backupName + ".tar.gz\" \"temp_" + backupName + "\"";
     
     if (system(tarCommand.c_str()) == 0) {
@@ -204,7 +544,7 @@ void BackupSystem::createBackup(const std::string& backupName) {
         std::cout << "📁 Archivo: " << finalBackup << std::endl;
         std::cout << "🗜️ Compresión: TAR.GZ aplicada" << std::endl;
         std::cout << "🔐 Encriptación: " << (encryptEnabled ? "XOR aplicada" : "No aplicada") << std::endl;
-        std::cout << "⚡ Paralelismo: OpenMP utilizado" << std::endl;
+        std::cout << "⚡ Paralelismo: pool de " << pool.size() << " hilos" << std::endl;
         
         // Mostrar tamaño del archivo
         struct stat st;
@@ -216,7 +556,33 @@ void BackupSystem::createBackup(const std::string& backupName) {
     }
 }
 
-void BackupSystem::copyAndProcessFile(const std::string& inputFile, const std::string& outputFile) {
+bool BackupSystem::nextDataExtent(int fd, off_t offset, off_t fileEnd, off_t& dataStart, off_t& dataEnd) {
+    if (offset >= fileEnd) {
+        return false;
+    }
+    
+    dataStart = lseek(fd, offset, SEEK_DATA);
+    if (dataStart == -1) {
+        if (errno == ENXIO) {
+            return false; // Solo queda un hueco hasta el final
+        }
+        // El sistema de archivos no soporta SEEK_DATA: tratar todo como datos
+        dataStart = offset;
+        dataEnd = fileEnd;
+        return true;
+    }
+    
+    dataEnd = lseek(fd, dataStart, SEEK_HOLE);
+    if (dataEnd == -1 || dataEnd > fileEnd) {
+        dataEnd = fileEnd;
+    }
+    return dataStart < dataEnd;
+}
+
+void BackupSystem::copyAndProcessFile(const std::string& inputFile, const std::string& outputFile,
+                                      ExtentList& extents) {
+    extents.clear();
+    
     int fdIn = open(inputFile.c_str(), O_RDONLY);
     if (fdIn == -1) return;
     
@@ -226,17 +592,44 @@ void BackupSystem::copyAndProcessFile(const std::string& inputFile, const std::s
         return;
     }
     
-    const size_t BUFFER_SIZE = 8192;
-    unsigned char buffer[BUFFER_SIZE];
+    // Buffer del hilo actual, reservado en su nodo NUMA
+    const size_t BUFFER_SIZE = 1024 * 1024;
+    unsigned char* buffer = ThreadPool::localBuffer(BUFFER_SIZE);
     ssize_t bytesRead;
     
-    while ((bytesRead = read(fdIn, buffer, BUFFER_SIZE)) > 0) {
-        // Encriptar si está habilitado
-        if (encryptEnabled) {
-            encryptBuffer(buffer, bytesRead);
+    // Copiar solo los extents con datos; los huecos se conservan como huecos
+    off_t fileEnd = lseek(fdIn, 0, SEEK_END);
+    off_t offset = 0;
+    off_t dataStart, dataEnd;
+    
+    while (nextDataExtent(fdIn, offset, fileEnd, dataStart, dataEnd)) {
+        offset = dataStart;
+        while (offset < dataEnd) {
+            size_t toRead = std::min((off_t)BUFFER_SIZE, dataEnd - offset);
+            bytesRead = pread(fdIn, buffer, toRead, offset);
+            if (bytesRead <= 0) {
+                break;
+            }
+            
+            // Encriptar si está habilitado
+            if (encryptEnabled) {
+                encryptBuffer(buffer, bytesRead);
+            }
+            
+            pwrite(fdOut, buffer, bytesRead, offset);
+            offset += bytesRead;
         }
         
-        write(fdOut, buffer, bytesRead);
+        // Registrar exactamente lo que se escribió (y encriptó)
+        if (offset > dataStart) {
+            extents.push_back(std::make_pair(dataStart, offset));
+        }
+        offset = dataEnd;
+    }
+    
+    // Extender hasta el tamaño original si el archivo termina en un hueco
+    if (fileEnd > 0) {
+        ftruncate(fdOut, fileEnd);
     }
     
     close(fdIn);
@@ -330,83 +723,173 @@ void BackupSystem::restoreBackup(const std::string& backupFile, const std::strin
     }
 }
 
+bool BackupSystem::writeExtentManifest(const std::string& manifestFile, const std::vector<std::string>& paths,
+                                       const std::vector<ExtentList>& extents) {
+    FILE* file = fopen(manifestFile.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    
+    // Una línea por archivo: "<n> <inicio> <fin> ... <longitud>:<ruta>\n"
+    // La longitud permite rutas con espacios, tabuladores o saltos de línea
+    fprintf(file, "BKE1\n");
+    for (size_t i = 0; i < paths.size(); i++) {
+        fprintf(file, "%zu", extents[i].size());
+        for (const auto& extent : extents[i]) {
+            fprintf(file, " %lld %lld", (long long)extent.first, (long long)extent.second);
+        }
+        fprintf(file, " %zu:", paths[i].size());
+        fwrite(paths[i].data(), 1, paths[i].size(), file);
+        fputc('\n', file);
+    }
+    
+    bool ok = !ferror(file);
+    return (fclose(file) == 0) && ok;
+}
+
+bool BackupSystem::loadExtentManifest(const std::string& manifestFile, std::vector<std::string>& paths,
+                                      std::vector<ExtentList>& extents) {
+    FILE* file = fopen(manifestFile.c_str(), "r");
+    if (!file) {
+        return false;
+    }
+    
+    char header[8] = {0};
+    bool valid = (fscanf(file, "%5s", header) == 1 && strcmp(header, "BKE1") == 0);
+    
+    size_t count;
+    while (valid && fscanf(file, "%zu", &count) == 1) {
+        ExtentList fileExtents;
+        for (size_t i = 0; i < count && valid; i++) {
+            long long start, end;
+            valid = (fscanf(file, "%lld %lld", &start, &end) == 2 && start >= 0 && start <= end);
+            fileExtents.push_back(std::make_pair((off_t)start, (off_t)end));
+        }
+        
+        size_t pathLength;
+        if (!valid || fscanf(file, " %zu:", &pathLength) != 1) {
+            valid = false;
+            break;
+        }
+        
+        std::string path(pathLength, '\0');
+        if (fread(&path[0], 1, pathLength, file) != pathLength || fgetc(file) != '\n') {
+            valid = false;
+            break;
+        }
+        
+        paths.push_back(path);
+        extents.push_back(fileExtents);
+    }
+    
+    valid = valid && feof(file);
+    fclose(file);
+    return valid;
+}
+
 void BackupSystem::decryptDirectory(const std::string& dirPath) {
     std::cout << "🔓 Desencriptando archivos en: " << dirPath << std::endl;
     
-    // Obtener lista de todos los archivos
     std::vector<std::string> filesToDecrypt;
-    std::string findCommand = "find \"" + dirPath + "\" -type f";
-    
-    FILE* pipe = popen(findCommand.c_str(), "r");
-    if (pipe) {
-        char buffer[1024];
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            std::string filePath = buffer;
-            // Remover newline
-            filePath.erase(filePath.find_last_not_of(" \n\r\t") + 1);
-            filesToDecrypt.push_back(filePath);
+    std::vector<ExtentList> extentsToDecrypt;
+    std::string manifestFile = dirPath + "/" + EXTENT_MANIFEST;
+    
+    struct stat manifestStat;
+    if (stat(manifestFile.c_str(), &manifestStat) == 0) {
+        // Desencriptar exactamente los rangos que se encriptaron al crear el backup
+        std::vector<std::string> relativePaths;
+        if (!loadExtentManifest(manifestFile, relativePaths, extentsToDecrypt)) {
+            std::cerr << "❌ Error: manifiesto de extents dañado, no se desencripta nada" << std::endl;
+            return;
+        }
+        for (const auto& relativePath : relativePaths) {
+            filesToDecrypt.push_back(dirPath + "/" + relativePath);
+        }
+    } else {
+        // Backup anterior al manifiesto: se encriptaron todos los bytes de cada archivo
+        std::map<std::pair<dev_t, ino_t>, bool> seenInodes;
+        std::string findCommand = "find \"" + dirPath + "\" -type f";
+        
+        FILE* pipe = popen(findCommand.c_str(), "r");
+        if (pipe) {
+            char buffer[1024];
+            while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+                std::string filePath = buffer;
+                // Remover newline
+                filePath.erase(filePath.find_last_not_of(" \n\r\t") + 1);
+                
+                struct stat fileStat;
+                if (stat(filePath.c_str(), &fileStat) != 0) {
+                    continue;
+                }
+                
+                // Los enlaces duros comparten contenido: desencriptar cada inodo una sola vez
+                if (fileStat.st_nlink > 1) {
+                    auto key = std::make_pair(fileStat.st_dev, fileStat.st_ino);
+                    if (seenInodes.count(key)) {
+                        continue;
+                    }
+                    seenInodes[key] = true;
+                }
+                filesToDecrypt.push_back(filePath);
+                extentsToDecrypt.push_back(ExtentList(1, std::make_pair((off_t)0, (off_t)fileStat.st_size)));
+            }
+            pclose(pipe);
         }
-        pclose(pipe);
     }
     
     std::cout << "Archivos a desencriptar: " << filesToDecrypt.size() << std::endl;
     
-    // Desencriptar archivos en paralelo usando OpenMP
+    // Desencriptar archivos en paralelo usando el pool
     int totalFiles = filesToDecrypt.size();
     int processedFiles = 0;
+    std::mutex progressMutex;
     
-    #pragma omp parallel for schedule(dynamic) shared(processedFiles)
-    for (int i = 0; i < totalFiles; i++) {
-        decryptSingleFile(filesToDecrypt[i]);
+    pool.parallelFor(totalFiles, [&](size_t i) {
+        decryptSingleFile(filesToDecrypt[i], extentsToDecrypt[i]);
         
-        #pragma omp critical
-        {
-            processedFiles++;
-            if (processedFiles % 10 == 0 || processedFiles == totalFiles) {
-                std::cout << "Desencriptados: " << processedFiles << "/" << totalFiles << std::endl;
-            }
+        std::lock_guard<std::mutex> lock(progressMutex);
+        processedFiles++;
+        if (processedFiles % 10 == 0 || processedFiles == totalFiles) {
+            std::cout << "Desencriptados: " << processedFiles << "/" << totalFiles << std::endl;
         }
-    }
+    });
     
+    unlink(manifestFile.c_str());
     std::cout << "✅ Desencriptación completada" << std::endl;
 }
 
-void BackupSystem::decryptSingleFile(const std::string& filePath) {
-    // Abrir archivo original
-    int fdIn = open(filePath.c_str(), O_RDONLY);
-    if (fdIn == -1) {
+void BackupSystem::decryptSingleFile(const std::string& filePath, const ExtentList& extents) {
+    // Desencriptar en el mismo archivo para conservar huecos y enlaces duros
+    int fd = open(filePath.c_str(), O_RDWR);
+    if (fd == -1) {
         return; // Skip si no se puede abrir
     }
     
-    // Crear archivo temporal
-    std::string tempFile = filePath + ".decrypt_tmp";
-    int fdOut = open(tempFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    if (fdOut == -1) {
-        close(fdIn);
-        return;
-    }
-    
     // Desencriptar usando XOR (la misma operación que encriptar)
-    const size_t BUFFER_SIZE = 8192;
-    unsigned char buffer[BUFFER_SIZE];
+    const size_t BUFFER_SIZE = 1024 * 1024;
+    unsigned char* buffer = ThreadPool::localBuffer(BUFFER_SIZE);
     ssize_t bytesRead;
     
-    while ((bytesRead = read(fdIn, buffer, BUFFER_SIZE)) > 0) {
-        // Aplicar XOR para desencriptar (misma operación que encriptar)
-        encryptBuffer(buffer, bytesRead);
-        
-        write(fdOut, buffer, bytesRead);
+    // Solo los rangos registrados al crear el backup; el resto son huecos sin encriptar
+    for (const auto& extent : extents) {
+        off_t offset = extent.first;
+        while (offset < extent.second) {
+            size_t toRead = std::min((off_t)BUFFER_SIZE, extent.second - offset);
+            bytesRead = pread(fd, buffer, toRead, offset);
+            if (bytesRead <= 0) {
+                break;
+            }
+            
+            // Aplicar XOR para desencriptar (misma operación que encriptar)
+            encryptBuffer(buffer, bytesRead);
+            
+            pwrite(fd, buffer, bytesRead, offset);
+            offset += bytesRead;
+        }
     }
     
-    close(fdIn);
-    close(fdOut);
-    
-    // Reemplazar archivo original con el desencriptado
-    if (rename(tempFile.c_str(), filePath.c_str()) != 0) {
-        // Si falla rename, intentar con comandos del sistema
-        std::string moveCommand = "mv \"" + tempFile + "\" \"" + filePath + "\"";
-        system(moveCommand.c_str());
-    }
+    close(fd);
 }
 
 void BackupSystem::showProgress(int current, int total, const std::string& currentFile) {
@@ -468,6 +951,14 @@ void BackupSystem::setOutputPath(const std::string& path) {
     outputPath = path;
 }
 
+void BackupSystem::setJournalPath(const std::string& path) {
+    journalPath = path;
+}
+
+void BackupSystem::showPoolStats() const {
+    pool.showStats();
+}
+
 void BackupSystem::showHelp() {
     std::cout << "=== SISTEMA DE BACKUP AVANZADO ===" << std::endl;
     std::cout << "Uso: ./backup [opciones] <carpeta>" << std::endl;
@@ -478,9 +969,19 @@ void BackupSystem::showHelp() {
     std::cout << "  -r, --restore <archivo.tar.gz> [destino] Restaura un backup" << std::endl;
     std::cout << "  -e, --encrypt        Habilita encriptación" << std::endl;
     std::cout << "  -o, --output <path>  Directorio de salida" << std::endl;
+    std::cout << "  -j, --journal <archivo> Usa un diario de cambios para evitar el escaneo completo" << std::endl;
+    std::cout << "  -w, --watch <carpeta> Modo vigilante: registra cambios en el diario (requiere -j)" << std::endl;
+    std::cout << "  -t, --threads <n>    Hilos del pool (por defecto: CPUs disponibles)" << std::endl;
+    std::cout << "  -p, --pin            Fija cada hilo a una CPU (buffers locales al nodo NUMA)" << std::endl;
+    std::cout << "      --cpus <lista>   Fija los hilos a estas CPUs, en orden (ej: 0-7,16-23); implica -p" << std::endl;
+    std::cout << "      --stats          Muestra uso y robos de trabajo por hilo al terminar" << std::endl;
     std::cout << "\nEjemplos:" << std::endl;
     std::cout << "  ./backup -s /home/user/documentos" << std::endl;
     std::cout << "  ./backup -e -b mi_backup /home/user/documentos" << std::endl;
     std::cout << "  ./backup -r mi_backup.tar.gz" << std::endl;
     std::cout << "  ./backup -e -r mi_backup.tar.gz restored_folder" << std::endl;
+    std::cout << "  ./backup -j docs.journal -w /home/user/documentos &" << std::endl;
+    std::cout << "  ./backup -j docs.journal -b mi_backup /home/user/documentos" << std::endl;
+    std::cout << "  ./backup -t 16 -p --stats -b mi_backup /home/user/documentos" << std::endl;
+    std::cout << "  ./backup --cpus 0-7,16-23 --stats -b mi_backup /home/user/documentos" << std::endl;
 }
\ No newline at end of file
@@ -9,8 +9,9 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <cstring>
-#include <omp.h>
+#include <mutex>
 #include <zlib.h>
+#include "threadPool.h"
 
 class BackupSystem {
 private:
@@ -18,29 +19,57 @@ private:
     bool encryptEnabled;
     unsigned char encryptionKey;
     std::string outputPath;
+    std::string journalPath;    // Vacío: siempre escaneo completo
     
     // Estructura para almacenar información de archivos
     struct FileInfo {
         std::string fullPath;
         std::string relativePath;
         size_t size;
+        size_t allocatedSize;   // Bytes realmente ocupados en disco (st_blocks)
+        dev_t device;
+        ino_t inode;
+        nlink_t linkCount;
+        long linkTarget;        // Índice del primer enlace duro, -1 si es el original
     };
     
     std::vector<FileInfo> fileList;
+    std::mutex fileListMutex;
+    
+    // Rangos [inicio, fin) con datos encriptados de cada archivo
+    typedef std::vector<std::pair<off_t, off_t>> ExtentList;
+    
+    // Manifiesto guardado en la raíz del backup encriptado: la restauración
+    // desencripta exactamente esos rangos en lugar de volver a buscar huecos
+    static const char* EXTENT_MANIFEST;
+    
+    // Pool persistente para escaneo, copia/encriptación y desencriptación
+    ThreadPool pool;
     
     // Métodos auxiliares
     void scanDirectory(const std::string& dirPath, const std::string& basePath);
+    void scanDirectoryTask(const std::string& dirPath, const std::string& basePath, ThreadPool::TaskGroup& group);
     void compressFile(const std::string& inputFile, const std::string& outputFile);
-    void copyAndProcessFile(const std::string& inputFile, const std::string& outputFile);
+    void copyAndProcessFile(const std::string& inputFile, const std::string& outputFile, ExtentList& extents);
     void decryptDirectory(const std::string& dirPath);
-    void decryptSingleFile(const std::string& filePath);
+    void decryptSingleFile(const std::string& filePath, const ExtentList& extents);
+    bool writeExtentManifest(const std::string& manifestFile, const std::vector<std::string>& paths,
+                             const std::vector<ExtentList>& extents);
+    bool loadExtentManifest(const std::string& manifestFile, std::vector<std::string>& paths,
+                            std::vector<ExtentList>& extents);
     void encryptBuffer(unsigned char* buffer, size_t size);
+    bool nextDataExtent(int fd, off_t offset, off_t fileEnd, off_t& dataStart, off_t& dataEnd);
+    void resolveHardLinks();
+    bool scanFromJournal(const std::string& folderPath, bool& indexUpToDate);
+    bool loadIndex(const std::string& indexFile, const std::string& folderPath);
+    void saveIndex(const std::string& indexFile, const std::string& folderPath);
     bool isDirectory(const std::string& path);
     void createDirectoryStructure(const std::string& path);
     
 public:
     // Constructor
-    BackupSystem(bool encrypt = false, unsigned char key = 0xAE);
+    BackupSystem(bool encrypt = false, unsigned char key = 0xAE, int threads = 0, bool pinThreads = false,
+                 const std::vector<int>& cpus = std::vector<int>());
     
     // Métodos principales
     void scanFolder(const std::string& folderPath);
@@ -51,6 +80,8 @@ public:
     // Métodos de utilidad
     void showFileList();
     void setOutputPath(const std::string& path);
+    void setJournalPath(const std::string& path);
+    void showPoolStats() const;
     static void showHelp();
 };
 
@@ -0,0 +1,465 @@
+#include "changeJournal.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <csignal>
+#include <random>
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+
+static const uint32_t WATCH_MASK = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE |
+                                   IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                   IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+// Entradas pendientes antes de forzar una escritura al diario
+static const size_t MAX_PENDING_PATHS = 4096;
+
+static std::string absolutePath(const std::string& path) {
+    char* resolved = realpath(path.c_str(), nullptr);
+    if (resolved == nullptr) {
+        return "";
+    }
+    std::string result(resolved);
+    free(resolved);
+    return result;
+}
+
+ChangeJournal::ChangeJournal(const std::string& path)
+    : journalPath(path), inotifyFd(-1), pendingOverflow(false), watchLost(false) {
+}
+
+std::string ChangeJournal::indexPath() const {
+    return journalPath + ".index";
+}
+
+void ChangeJournal::addWatches(const std::string& relativeDir) {
+    std::string dirPath = relativeDir.empty() ? rootPath : rootPath + "/" + relativeDir;
+
+    int wd = inotify_add_watch(inotifyFd, dirPath.c_str(), WATCH_MASK);
+    if (wd == -1) {
+        // Una subcarpeta borrada o movida antes de vigilarla ya quedó registrada
+        // por el evento de su carpeta padre
+        if (!relativeDir.empty() && (errno == ENOENT || errno == ENOTDIR)) {
+            return;
+        }
+        if (errno == ENOSPC) {
+            std::cerr << "⚠️ Límite de inotify alcanzado (fs.inotify.max_user_watches)" << std::endl;
+        }
+        std::cerr << "⚠️ No se pudo vigilar: " << dirPath << std::endl;
+        watchLost = true;
+        return;
+    }
+    // Una carpeta movida conserva su wd: actualizar su ruta relativa
+    watchedDirs[wd] = relativeDir;
+
+    DIR* dir = opendir(dirPath.c_str());
+    if (!dir) {
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        std::string childRelative = relativeDir.empty() ? entry->d_name : relativeDir + "/" + entry->d_name;
+        struct stat statbuf;
+        if (stat((rootPath + "/" + childRelative).c_str(), &statbuf) == 0 && S_ISDIR(statbuf.st_mode)) {
+            addWatches(childRelative);
+        }
+    }
+    closedir(dir);
+}
+
+void ChangeJournal::handleEvents(const char* buffer, ssize_t length) {
+    const char* ptr = buffer;
+    while (ptr < buffer + length) {
+        const struct inotify_event* event = (const struct inotify_event*)ptr;
+        ptr += sizeof(struct inotify_event) + event->len;
+
+        if (event->mask & IN_Q_OVERFLOW) {
+            pendingOverflow = true;
+            continue;
+        }
+
+        auto it = watchedDirs.find(event->wd);
+        if (it == watchedDirs.end()) {
+            continue;
+        }
+        std::string relativeDir = it->second;
+
+        if (event->mask & IN_IGNORED) {
+            watchedDirs.erase(it);
+            continue;
+        }
+
+        if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+            // Si desaparece la raíz no hay forma de seguir el árbol
+            if (relativeDir.empty()) {
+                std::cerr << "⚠️ La carpeta vigilada fue borrada o movida" << std::endl;
+                watchLost = true;
+            }
+            continue;
+        }
+
+        if (event->len == 0) {
+            continue;
+        }
+
+        std::string relativePath = relativeDir.empty() ? event->name : relativeDir + "/" + event->name;
+        if (relativePath.find('\n') != std::string::npos) {
+            // No representable en el diario
+            pendingOverflow = true;
+            continue;
+        }
+        pendingPaths.insert(relativePath);
+
+        // Carpetas nuevas o movidas dentro del árbol también deben vigilarse
+        if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+            addWatches(relativePath);
+        }
+    }
+}
+
+void ChangeJournal::drainEvents() {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    ssize_t length;
+    while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+        handleEvents(buffer, length);
+    }
+}
+
+void ChangeJournal::appendToJournal(const std::string& records, bool force) {
+    while (true) {
+        int fd = open(journalPath.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fd == -1) {
+            std::cerr << "Error al abrir diario: " << journalPath << std::endl;
+            return;
+        }
+        flock(fd, LOCK_EX);
+
+        // El backup pudo consumir el diario mientras esperábamos el lock
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_nlink == 0) {
+            close(fd);
+            continue;
+        }
+
+        if (force) {
+            // Registros de sincronización: son pequeños y el backup los espera
+            write(fd, records.data(), records.size());
+        } else if ((size_t)st.st_size >= MAX_JOURNAL_BYTES) {
+            // Ya se marcó el desbordamiento, no seguir creciendo
+        } else if ((size_t)st.st_size + records.size() > MAX_JOURNAL_BYTES) {
+            write(fd, "O\n", 2);
+        } else {
+            write(fd, records.data(), records.size());
+        }
+
+        close(fd);
+        return;
+    }
+}
+
+void ChangeJournal::flushPending() {
+    if (pendingPaths.empty() && !pendingOverflow && !watchLost) {
+        return;
+    }
+
+    std::string records;
+    if (pendingOverflow || watchLost) {
+        records = "O\n";
+    } else {
+        for (const auto& path : pendingPaths) {
+            records += "C " + path + "\n";
+        }
+    }
+    appendToJournal(records);
+
+    pendingPaths.clear();
+    pendingOverflow = false;
+}
+
+void ChangeJournal::watch(const std::string& folderPath) {
+    std::cout << "\n=== MODO VIGILANTE ===" << std::endl;
+
+    rootPath = absolutePath(folderPath);
+    if (rootPath.empty()) {
+        std::cerr << "Error: '" << folderPath << "' no es una carpeta válida" << std::endl;
+        return;
+    }
+
+    // La petición de sincronización del backup llega por signalfd; bloquear la
+    // señal antes de anunciar el pid para que nunca aplique la acción por defecto
+    sigset_t syncSignals;
+    sigemptyset(&syncSignals);
+    sigaddset(&syncSignals, SIGRTMIN);
+    sigprocmask(SIG_BLOCK, &syncSignals, nullptr);
+
+    int signalFd = signalfd(-1, &syncSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd == -1) {
+        std::cerr << "Error inicializando signalfd" << std::endl;
+        return;
+    }
+
+    // El lock compartido indica al backup que hay un vigilante activo en esta raíz
+    std::string lockPath = journalPath + ".lock";
+    int lockFd = open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (lockFd == -1 || flock(lockFd, LOCK_SH) != 0) {
+        std::cerr << "Error al crear lock del diario: " << lockPath << std::endl;
+        if (lockFd != -1) close(lockFd);
+        close(signalFd);
+        return;
+    }
+    ftruncate(lockFd, 0);
+    std::string lockContent = std::to_string(getpid()) + "\n" + rootPath + "\n";
+    write(lockFd, lockContent.data(), lockContent.size());
+
+    inotifyFd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotifyFd == -1) {
+        std::cerr << "Error inicializando inotify" << std::endl;
+        close(lockFd);
+        close(signalFd);
+        return;
+    }
+
+    addWatches("");
+    std::cout << "Carpeta: " << rootPath << std::endl;
+    std::cout << "Diario: " << journalPath << std::endl;
+    std::cout << "Carpetas vigiladas: " << watchedDirs.size() << std::endl;
+
+    // Lo ocurrido antes de arrancar es desconocido: el próximo backup escanea todo
+    pendingOverflow = true;
+    flushPending();
+
+    if (watchLost) {
+        std::cerr << "Error: no se pudo vigilar todo el árbol, el vigilante termina" << std::endl;
+        close(inotifyFd);
+        close(signalFd);
+        close(lockFd);
+        return;
+    }
+
+    struct pollfd pfds[2];
+    pfds[0].fd = inotifyFd;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = signalFd;
+    pfds[1].events = POLLIN;
+
+    while (true) {
+        int ready = poll(pfds, 2, 1000);
+        if (ready == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        if (pfds[0].revents & POLLIN) {
+            drainEvents();
+        }
+
+        if (pfds[1].revents & POLLIN) {
+            std::string syncRecords;
+            struct signalfd_siginfo info;
+            while (read(signalFd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+                syncRecords += "S " + std::to_string(info.ssi_int) + "\n";
+            }
+
+            // Todo cambio anterior a la petición ya está en la cola de inotify:
+            // vaciarla y escribirlo antes de confirmar
+            drainEvents();
+            flushPending();
+            appendToJournal(syncRecords, true);
+        } else if (ready == 0 || pendingPaths.size() >= MAX_PENDING_PATHS || pendingOverflow || watchLost) {
+            // Agrupar eventos: escribir cada segundo o al acumular muchas rutas
+            flushPending();
+        }
+
+        // Con una vigilancia perdida el diario dejaría de ser fiable para siempre:
+        // terminar ya escrito el "O" y liberar el lock para que el backup escanee todo
+        if (watchLost) {
+            std::cerr << "Error: parte del árbol quedó sin vigilar, el vigilante termina" << std::endl;
+            break;
+        }
+    }
+
+    flushPending();
+    close(inotifyFd);
+    close(signalFd);
+    close(lockFd);
+}
+
+bool ChangeJournal::readWatcher(const std::string& folderPath, pid_t& pid) const {
+    std::string lockPath = journalPath + ".lock";
+    int lockFd = open(lockPath.c_str(), O_RDONLY);
+    if (lockFd == -1) {
+        return false;
+    }
+
+    // Si el lock exclusivo se obtiene, ningún vigilante lo mantiene
+    if (flock(lockFd, LOCK_EX | LOCK_NB) == 0) {
+        flock(lockFd, LOCK_UN);
+        close(lockFd);
+        return false;
+    }
+
+    char buffer[4096];
+    ssize_t length = read(lockFd, buffer, sizeof(buffer) - 1);
+    close(lockFd);
+    if (length <= 0) {
+        return false;
+    }
+    buffer[length] = '\0';
+
+    // Contenido: "<pid>\n<carpeta absoluta>\n"
+    std::string content(buffer);
+    size_t newline = content.find('\n');
+    if (newline == std::string::npos) {
+        return false;
+    }
+    pid = (pid_t)atol(content.substr(0, newline).c_str());
+
+    std::string watchedRoot = content.substr(newline + 1);
+    watchedRoot.erase(watchedRoot.find_last_not_of("\n") + 1);
+    return pid > 0 && watchedRoot == absolutePath(folderPath);
+}
+
+bool ChangeJournal::watcherActive(const std::string& folderPath) const {
+    pid_t pid;
+    return readWatcher(folderPath, pid);
+}
+
+bool ChangeJournal::requestSync(pid_t pid) {
+    std::random_device random;
+    int nonce = (int)(random() & 0x7fffffff);
+
+    union sigval value;
+    value.sival_int = nonce;
+    if (sigqueue(pid, SIGRTMIN, value) != 0) {
+        std::cerr << "⚠️ No se pudo contactar al vigilante (pid " << pid << ")" << std::endl;
+        return false;
+    }
+
+    if (!waitForSync("S " + std::to_string(nonce))) {
+        std::cerr << "⚠️ El vigilante no confirmó la sincronización a tiempo" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ChangeJournal::waitForSync(const std::string& record) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SYNC_TIMEOUT_MS);
+    int fd = -1;
+    std::string partialLine;
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        // El vigilante crea el diario si no existía
+        if (fd == -1) {
+            fd = open(journalPath.c_str(), O_RDONLY);
+            partialLine.clear();
+        }
+
+        if (fd != -1) {
+            char buffer[8192];
+            ssize_t bytesRead;
+            while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0) {
+                partialLine.append(buffer, bytesRead);
+
+                size_t newline;
+                while ((newline = partialLine.find('\n')) != std::string::npos) {
+                    if (partialLine.compare(0, newline, record) == 0 && newline == record.size()) {
+                        close(fd);
+                        return true;
+                    }
+                    partialLine.erase(0, newline + 1);
+                }
+            }
+
+            // Otro backup consumió el diario: seguir leyendo el nuevo
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_nlink == 0) {
+                close(fd);
+                fd = -1;
+                continue;
+            }
+        }
+
+        usleep(5000);
+    }
+
+    if (fd != -1) {
+        close(fd);
+    }
+    return false;
+}
+
+bool ChangeJournal::consume(const std::string& folderPath, std::vector<std::string>& changedPaths) {
+    changedPaths.clear();
+    std::string consumedPath = journalPath + ".consumed";
+
+    // Con vigilante activo, pedirle que vacíe su cola antes de consumir el diario;
+    // sin su confirmación el diario puede estar incompleto
+    pid_t watcherPid;
+    bool valid = readWatcher(folderPath, watcherPid) && requestSync(watcherPid);
+
+    // Mover el diario actual a .consumed. Se conserva hasta commit(), que se llama
+    // al guardar el índice tras el escaneo: si el escaneo se interrumpe, la próxima
+    // ejecución vuelve a aplicar estas rutas. El éxito del backup no influye porque
+    // cada backup es completo y el índice solo refleja el estado escaneado
+    int fd = open(journalPath.c_str(), O_RDONLY);
+    if (fd != -1) {
+        flock(fd, LOCK_EX);
+
+        int fdOut = open(consumedPath.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fdOut == -1) {
+            close(fd);
+            return false;
+        }
+
+        char buffer[8192];
+        ssize_t bytesRead;
+        while ((bytesRead = read(fd, buffer, sizeof(buffer))) > 0) {
+            write(fdOut, buffer, bytesRead);
+        }
+        close(fdOut);
+
+        unlink(journalPath.c_str());
+        close(fd);
+    }
+
+    FILE* file = fopen(consumedPath.c_str(), "r");
+    if (file) {
+        char* line = nullptr;
+        size_t capacity = 0;
+        ssize_t length;
+        std::set<std::string> uniquePaths;
+
+        while ((length = getline(&line, &capacity, file)) != -1) {
+            std::string record(line, length);
+            record.erase(record.find_last_not_of("\n") + 1);
+
+            if (record == "O") {
+                valid = false;
+            } else if (record.size() > 2 && record.compare(0, 2, "C ") == 0) {
+                uniquePaths.insert(record.substr(2));
+            }
+        }
+        free(line);
+        fclose(file);
+
+        changedPaths.assign(uniquePaths.begin(), uniquePaths.end());
+    }
+
+    return valid;
+}
+
+void ChangeJournal::commit() {
+    unlink((journalPath + ".consumed").c_str());
+}
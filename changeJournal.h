@@ -0,0 +1,65 @@
+#ifndef CHANGE_JOURNAL_H
+#define CHANGE_JOURNAL_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <unistd.h>
+
+// Diario de cambios persistente alimentado por inotify.
+//
+// El modo vigilante (-w) registra en <diario> las rutas relativas que cambian
+// entre ejecuciones. El siguiente backup aplica esas rutas sobre <diario>.index
+// (la lista de archivos del último escaneo) en lugar de recorrer todo el árbol.
+// Formato del diario, una entrada por línea:
+//   C <ruta relativa>   la ruta (archivo o carpeta) cambió
+//   O                   desbordamiento: hace falta un escaneo completo
+//   S <n>               el vigilante vació su cola tras la petición <n> del backup
+//
+// Si el vigilante pierde una vigilancia (límite de inotify, carpeta nueva sin
+// vigilar o raíz borrada/movida) registra "O" y termina liberando el lock: sin
+// vigilante activo el backup nunca considera válido el diario.
+class ChangeJournal {
+private:
+    std::string journalPath;
+
+    // Estado del vigilante
+    int inotifyFd;
+    std::string rootPath;
+    std::map<int, std::string> watchedDirs;   // wd -> ruta relativa de la carpeta
+    std::set<std::string> pendingPaths;
+    bool pendingOverflow;
+    bool watchLost;         // Parte del árbol quedó sin vigilar: el vigilante termina
+
+    void addWatches(const std::string& relativeDir);
+    void handleEvents(const char* buffer, ssize_t length);
+    void drainEvents();
+    void flushPending();
+    void appendToJournal(const std::string& records, bool force = false);
+
+    // Lado del backup
+    bool readWatcher(const std::string& folderPath, pid_t& pid) const;
+    bool requestSync(pid_t pid);
+    bool waitForSync(const std::string& record);
+
+public:
+    // Límite del diario; al superarlo se registra "O" y se deja de crecer
+    static const size_t MAX_JOURNAL_BYTES = 64 * 1024 * 1024;
+
+    // Espera máxima a que el vigilante confirme la sincronización
+    static const int SYNC_TIMEOUT_MS = 5000;
+
+    explicit ChangeJournal(const std::string& path);
+
+    // Modo vigilante: bloquea el proceso registrando cambios en el diario
+    void watch(const std::string& folderPath);
+
+    // Lado del backup
+    bool watcherActive(const std::string& folderPath) const;
+    bool consume(const std::string& folderPath, std::vector<std::string>& changedPaths);
+    void commit();          // Llamar tras guardar el índice del escaneo
+    std::string indexPath() const;
+};
+
+#endif
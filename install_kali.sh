@@ -63,7 +63,7 @@ fi
 
 # Instalar dependencias
 print_status "Instalando dependencias necesarias..."
-PACKAGES="build-essential zlib1g-dev libz-dev libomp-dev libgomp1 pkg-config make"
+PACKAGES="build-essential zlib1g-dev libz-dev pkg-config make"
 
 if sudo apt install -y $PACKAGES; then
     print_success "Dependencias instaladas correctamente"
@@ -82,24 +82,26 @@ else
     exit 1
 fi
 
-# Verificar OpenMP
-print_status "Verificando soporte OpenMP..."
-cat > test_openmp.cpp << 'EOF'
-#include <omp.h>
+# Verificar soporte de hilos (std::thread / pthread) usado por el pool
+print_status "Verificando soporte de hilos..."
+cat > test_threads.cpp << 'EOF'
+#include <thread>
 #include <iostream>
 int main() {
-    std::cout << "OpenMP threads: " << omp_get_max_threads() << std::endl;
+    std::thread worker([] {});
+    worker.join();
+    std::cout << "Hilos: " << std::thread::hardware_concurrency() << std::endl;
     return 0;
 }
 EOF
 
-if g++ -fopenmp test_openmp.cpp -o test_openmp && ./test_openmp; then
-    THREADS=$(./test_openmp | grep -o '[0-9]*')
-    print_success "OpenMP funcionando correctamente ($THREADS hilos disponibles)"
-    rm -f test_openmp test_openmp.cpp
+if g++ -std=c++17 -pthread test_threads.cpp -o test_threads && ./test_threads; then
+    THREADS=$(./test_threads | grep -o '[0-9]*')
+    print_success "Hilos funcionando correctamente ($THREADS CPUs disponibles)"
+    rm -f test_threads test_threads.cpp
 else
-    print_error "OpenMP no funciona correctamente"
-    rm -f test_openmp test_openmp.cpp
+    print_error "El soporte de hilos no funciona correctamente"
+    rm -f test_threads test_threads.cpp
     exit 1
 fi
 
@@ -160,6 +162,7 @@ if [ -f "Makefile" ]; then
                     echo "  ./backup -s /ruta/carpeta      # Escanear carpeta"
                     echo "  ./backup -b nombre /ruta       # Crear backup"
                     echo "  ./backup -e -b nombre /ruta    # Backup encriptado"
+                    echo "  ./backup -t 8 -p --stats -b nombre /ruta  # Hilos fijados + estadísticas"
                     echo
                     echo "Ejemplos para Kali:"
                     echo "  ./backup -s ~/Desktop"
@@ -1,6 +1,8 @@
 #include "backupSystem.h"
+#include "changeJournal.h"
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
 #include <ctime>
 
 int main(int argc, char* argv[]) {
@@ -13,6 +15,12 @@ int main(int argc, char* argv[]) {
     bool restoreMode = false;
     std::string backupFile = "";
     std::string restoreDir = "";
+    std::string journalPath = "";
+    bool watchMode = false;
+    int threads = 0;
+    bool pinThreads = false;
+    std::vector<int> cpus;
+    bool showStats = false;
     
     // Procesar argumentos
     if (argc < 2) {
@@ -69,6 +77,45 @@ int main(int argc, char* argv[]) {
                 return 1;
             }
         }
+        else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--journal") == 0) {
+            if (i + 1 < argc) {
+                journalPath = argv[++i];
+            } else {
+                std::cerr << "Error: Se requiere especificar el archivo de diario" << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "--watch") == 0) {
+            if (i + 1 < argc) {
+                targetFolder = argv[++i];
+                watchMode = true;
+            } else {
+                std::cerr << "Error: Se requiere especificar la carpeta a vigilar" << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--threads") == 0) {
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0) {
+                threads = atoi(argv[++i]);
+            } else {
+                std::cerr << "Error: Se requiere un número de hilos válido" << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-p") == 0 || strcmp(argv[i], "--pin") == 0) {
+            pinThreads = true;
+        }
+        else if (strcmp(argv[i], "--cpus") == 0) {
+            if (i + 1 < argc && ThreadPool::parseCpuList(argv[i + 1], cpus)) {
+                i++;
+            } else {
+                std::cerr << "Error: Se requiere una lista de CPUs válida (ej: 0-7,16-23)" << std::endl;
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--stats") == 0) {
+            showStats = true;
+        }
         else if (argv[i][0] != '-') {
             // Si no es una opción, asumir que es la carpeta objetivo
             if (targetFolder.empty() && !restoreMode) {
@@ -84,11 +131,14 @@ int main(int argc, char* argv[]) {
         std::cout << "Directorio salida: " << (restoreDir.empty() ? "[Automático]" : restoreDir) << std::endl;
         std::cout << "Encriptación: " << (encryptEnabled ? "SÍ (se desencriptará)" : "NO") << std::endl;
         
-        BackupSystem restoreSystem(encryptEnabled, 0xAE);
+        BackupSystem restoreSystem(encryptEnabled, 0xAE, threads, pinThreads, cpus);
         restoreSystem.setOutputPath(outputPath);
         
         try {
             restoreSystem.restoreBackup(backupFile, restoreDir);
+            if (showStats) {
+                restoreSystem.showPoolStats();
+            }
             std::cout << "\n=== RESTAURACIÓN COMPLETADA ===" << std::endl;
             std::cout << "✅ Backup restaurado exitosamente" << std::endl;
         } catch (const std::exception& e) {
@@ -99,6 +149,18 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
+    // **MODO VIGILANTE**
+    if (watchMode) {
+        if (journalPath.empty()) {
+            std::cerr << "Error: El modo vigilante requiere un diario (-j <archivo>)" << std::endl;
+            return 1;
+        }
+        
+        ChangeJournal journal(journalPath);
+        journal.watch(targetFolder);
+        return 1; // watch() solo regresa si hubo un error
+    }
+    
     // **MODO BACKUP/ESCANEO**
     // Validar argumentos para backup/escaneo
     if (targetFolder.empty()) {
@@ -112,6 +174,7 @@ int main(int argc, char* argv[]) {
     std::cout << "Carpeta objetivo: " << targetFolder << std::endl;
     std::cout << "Directorio salida: " << outputPath << std::endl;
     std::cout << "Encriptación: " << (encryptEnabled ? "SÍ" : "NO") << std::endl;
+    std::cout << "Diario de cambios: " << (journalPath.empty() ? "NO" : journalPath) << std::endl;
     
     if (!scanOnly && backupName.empty()) {
         std::cout << "Nombre backup: [Automático basado en fecha]" << std::endl;
@@ -128,8 +191,9 @@ int main(int argc, char* argv[]) {
     }
     
     // Crear instancia del sistema de backup
-    BackupSystem backupSystem(encryptEnabled, 0xAE);
+    BackupSystem backupSystem(encryptEnabled, 0xAE, threads, pinThreads, cpus);
     backupSystem.setOutputPath(outputPath);
+    backupSystem.setJournalPath(journalPath);
     
     try {
         // Escanear carpeta
@@ -152,7 +216,7 @@ int main(int argc, char* argv[]) {
             std::cout << "📁 Archivo: " << backupName << ".tar.gz" << std::endl;
             std::cout << "🗜️ Compresión: TAR.GZ aplicada" << std::endl;
             std::cout << "🔐 Encriptación: " << (encryptEnabled ? "XOR aplicada" : "No aplicada") << std::endl;
-            std::cout << "⚡ Paralelismo OpenMP: Utilizado para optimización" << std::endl;
+            std::cout << "⚡ Paralelismo: Pool persistente con robo de trabajo" << std::endl;
             
             std::cout << "\n💡 Para restaurar este backup:" << std::endl;
             if (encryptEnabled) {
@@ -162,6 +226,10 @@ int main(int argc, char* argv[]) {
             }
         }
         
+        if (showStats) {
+            backupSystem.showPoolStats();
+        }
+        
     } catch (const std::exception& e) {
         std::cerr << "Error durante el proceso: " << e.what() << std::endl;
         return 1;
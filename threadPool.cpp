@@ -0,0 +1,337 @@
+#include "threadPool.h"
+#include <iostream>
+#include <cstdio>
+#include <iomanip>
+#include <algorithm>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Hilo del pool que ejecuta el código actual (-1 fuera del pool)
+static thread_local int currentWorker = -1;
+static thread_local const ThreadPool* currentPool = nullptr;
+
+ThreadPool::ThreadPool(int threads, bool pin, const std::vector<int>& cpus)
+    : pinThreads(pin || !cpus.empty()) {
+    std::vector<int> allowedCpus;
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &cpuSet)) {
+                allowedCpus.push_back(cpu);
+            }
+        }
+    }
+
+    // Lista explícita: conservar su orden, descartando CPUs fuera de la afinidad del proceso
+    for (int cpu : cpus) {
+        if (std::find(allowedCpus.begin(), allowedCpus.end(), cpu) != allowedCpus.end()) {
+            pinCpus.push_back(cpu);
+        } else {
+            std::cerr << "⚠️ CPU " << cpu << " no disponible para este proceso, se ignora" << std::endl;
+        }
+    }
+    if (pinCpus.empty()) {
+        if (!cpus.empty()) {
+            std::cerr << "⚠️ Ninguna CPU de la lista es válida, usando todas las permitidas" << std::endl;
+        }
+        pinCpus = allowedCpus;
+    }
+
+    if (threads <= 0) {
+        threads = !cpus.empty() ? (int)pinCpus.size()
+                : allowedCpus.empty() ? (int)std::thread::hardware_concurrency() : (int)allowedCpus.size();
+        if (threads <= 0) threads = 1;
+    }
+
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (int i = 0; i < threads; i++) {
+        workers[i]->thread = std::thread(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    sleepCondition.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    Worker& self = *workers[index];
+    currentWorker = (int)index;
+    currentPool = this;
+
+    if (pinThreads && !pinCpus.empty()) {
+        cpu_set_t cpuSet;
+        CPU_ZERO(&cpuSet);
+        CPU_SET(pinCpus[index % pinCpus.size()], &cpuSet);
+
+        // Registrar CPU y nodo NUMA solo si quedó fijado: sin afinidad cambian en cualquier momento
+        unsigned int cpu = 0, node = 0;
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0 &&
+            syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+            self.cpu = (int)cpu;
+            self.node = (int)node;
+        }
+    }
+
+    while (true) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            runTask(task, (int)index);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait(lock, [this] { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::popLocal(size_t index, Task& task) {
+    Worker& worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    queuedTasks--;
+    return true;
+}
+
+bool ThreadPool::steal(size_t thief, Task& task) {
+    size_t count = workers.size();
+    int thiefNode = thief < count ? workers[thief]->node.load() : -1;
+
+    // Con hilos fijados, primera pasada: víctimas del mismo nodo NUMA; segunda: el resto.
+    // Sin fijar el nodo de cada hilo no es estable, así que hay una sola pasada
+    int passes = pinThreads ? 2 : 1;
+    for (int pass = 0; pass < passes; pass++) {
+        for (size_t offset = 1; offset <= count; offset++) {
+            size_t victim = (thief + offset) % count;
+            if (victim == thief) continue;
+
+            Worker& worker = *workers[victim];
+            bool sameNode = (worker.node == thiefNode);
+            if (pinThreads && (pass == 0) != sameNode) continue;
+
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.tasks.empty()) continue;
+
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            queuedTasks--;
+            countersFor(thief < count ? (int)thief : -1).steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::findTask(Task& task) {
+    if (currentPool == this && currentWorker >= 0) {
+        return popLocal(currentWorker, task) || steal(currentWorker, task);
+    }
+    // Hilo externo: roba de cualquier cola
+    return steal(workers.size(), task);
+}
+
+ThreadPool::Counters& ThreadPool::countersFor(int workerIndex) {
+    return workerIndex >= 0 ? workers[workerIndex]->counters : callerCounters;
+}
+
+void ThreadPool::runTask(Task& task, int workerIndex) {
+    auto begin = std::chrono::steady_clock::now();
+    task.function();
+    auto end = std::chrono::steady_clock::now();
+
+    Counters& counters = countersFor(workerIndex);
+    counters.tasksRun++;
+    counters.busyNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+
+    {
+        // Cerrar el periodo activo cuando termina la última tarea pendiente
+        std::lock_guard<std::mutex> lock(activityMutex);
+        if (--outstandingTasks == 0) {
+            activeNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - activeSince).count();
+        }
+    }
+
+    if (--task.group->pending == 0) {
+        // Despertar a quien espera en wait()
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        sleepCondition.notify_all();
+    }
+}
+
+void ThreadPool::spawn(TaskGroup& group, std::function<void()> function) {
+    group.pending++;
+
+    {
+        // Abrir un periodo activo si el pool estaba ocioso
+        std::lock_guard<std::mutex> lock(activityMutex);
+        if (outstandingTasks++ == 0) {
+            activeSince = std::chrono::steady_clock::now();
+        }
+    }
+
+    // Desde un hilo del pool la tarea va a su propia cola; si no, reparto circular
+    size_t index;
+    if (currentPool == this && currentWorker >= 0) {
+        index = currentWorker;
+    } else {
+        index = nextQueue++ % workers.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(Task{std::move(function), &group});
+        queuedTasks++;
+    }
+
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    sleepCondition.notify_one();
+}
+
+void ThreadPool::wait(TaskGroup& group) {
+    int workerIndex = (currentPool == this) ? currentWorker : -1;
+
+    // Quien espera también ejecuta tareas: evita bloqueos con tareas anidadas
+    while (group.pending > 0) {
+        Task task;
+        if (findTask(task)) {
+            runTask(task, workerIndex);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleepCondition.wait_for(lock, std::chrono::milliseconds(1),
+                                [this, &group] { return group.pending == 0 || queuedTasks > 0; });
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    // Varios bloques por hilo para que el robo pueda equilibrar la carga
+    size_t chunks = std::min(count, workers.size() * 8);
+    size_t chunkSize = (count + chunks - 1) / chunks;
+
+    TaskGroup group;
+    for (size_t begin = 0; begin < count; begin += chunkSize) {
+        size_t end = std::min(count, begin + chunkSize);
+        spawn(group, [&body, begin, end] {
+            for (size_t i = begin; i < end; i++) {
+                body(i);
+            }
+        });
+    }
+    wait(group);
+}
+
+int ThreadPool::size() const {
+    return (int)workers.size();
+}
+
+bool ThreadPool::pinned() const {
+    return pinThreads;
+}
+
+void ThreadPool::showStats() const {
+    // El uso se mide sobre el tiempo con tareas pendientes, no desde la creación del pool
+    double activeWall;
+    {
+        std::lock_guard<std::mutex> lock(activityMutex);
+        activeWall = activeNanos;
+        if (outstandingTasks > 0) {
+            activeWall += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - activeSince).count();
+        }
+    }
+
+    std::cout << "\n=== ESTADÍSTICAS DEL POOL ===" << std::endl;
+    std::cout << "Hilos: " << workers.size() << (pinThreads ? " (fijados a CPU)" : "") << std::endl;
+    std::cout << "Tiempo activo: " << std::fixed << std::setprecision(3) << activeWall / 1e9 << " s" << std::endl;
+    std::cout << "Hilo  CPU  Nodo  Tareas      Robos       Uso" << std::endl;
+
+    uint64_t totalTasks = 0;
+    auto printRow = [&](const std::string& name, const std::string& cpu, const std::string& node,
+                        const Counters& counters) {
+        double utilization = activeWall > 0 ? (100.0 * counters.busyNanos / activeWall) : 0.0;
+        totalTasks += counters.tasksRun;
+        std::cout << std::left << std::setw(6) << name
+                  << std::setw(5) << cpu
+                  << std::setw(6) << node
+                  << std::setw(12) << counters.tasksRun.load()
+                  << std::setw(12) << counters.steals.load()
+                  << std::fixed << std::setprecision(1) << utilization << "%" << std::endl;
+    };
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        const Worker& worker = *workers[i];
+        printRow(std::to_string(i),
+                 pinThreads ? std::to_string(worker.cpu.load()) : "-",
+                 pinThreads ? std::to_string(worker.node.load()) : "-",
+                 worker.counters);
+    }
+    // Hilo(s) que esperan en wait() y ejecutan tareas mientras tanto
+    printRow("princ", "-", "-", callerCounters);
+
+    std::cout << std::right << "Total tareas: " << totalTasks << std::endl;
+}
+
+unsigned char* ThreadPool::localBuffer(size_t size) {
+    static thread_local std::vector<unsigned char> buffer;
+    if (buffer.size() < size) {
+        buffer.resize(size);
+    }
+    return buffer.data();
+}
+
+bool ThreadPool::parseCpuList(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    size_t position = 0;
+
+    while (position <= text.size()) {
+        size_t comma = text.find(',', position);
+        if (comma == std::string::npos) comma = text.size();
+        std::string item = text.substr(position, comma - position);
+        position = comma + 1;
+
+        // Cada elemento es "n" o "inicio-fin"
+        int first, last;
+        char extra;
+        if (sscanf(item.c_str(), "%d-%d%c", &first, &last, &extra) == 2) {
+            // Rango
+        } else if (sscanf(item.c_str(), "%d%c", &first, &extra) == 1) {
+            last = first;
+        } else {
+            return false;
+        }
+
+        if (first < 0 || last < first || last >= CPU_SETSIZE) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return !cpus.empty();
+}
@@ -0,0 +1,101 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Pool persistente de hilos con robo de trabajo.
+//
+// Cada hilo tiene su propia cola: saca tareas por el final (LIFO) y, cuando se
+// vacía, roba por el principio de otras colas; con hilos fijados, primero de
+// hilos en su mismo nodo NUMA. Sustituye a las regiones OpenMP que se creaban
+// en cada llamada.
+class ThreadPool {
+public:
+    // Contador de tareas pendientes de un grupo; wait() espera a que llegue a 0
+    struct TaskGroup {
+        std::atomic<size_t> pending{0};
+    };
+
+private:
+    struct Task {
+        std::function<void()> function;
+        TaskGroup* group;
+    };
+
+    // Estadísticas de un hilo que ejecuta tareas
+    struct Counters {
+        std::atomic<uint64_t> tasksRun{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<uint64_t> busyNanos{0};
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+        std::atomic<int> cpu{-1};
+        std::atomic<int> node{-1};
+        Counters counters;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    bool pinThreads;
+    std::vector<int> pinCpus;       // CPU asignada al hilo i: pinCpus[i % n]
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<size_t> queuedTasks{0};
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<bool> stopping{false};
+
+    // Hilos externos (el principal) que ejecutan tareas mientras esperan en wait()
+    Counters callerCounters;
+
+    // Tiempo con trabajo pendiente: base para calcular el uso de cada hilo
+    mutable std::mutex activityMutex;
+    size_t outstandingTasks = 0;
+    std::chrono::steady_clock::time_point activeSince;
+    uint64_t activeNanos = 0;
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+    bool findTask(Task& task);
+    void runTask(Task& task, int workerIndex);
+    Counters& countersFor(int workerIndex);
+
+public:
+    // cpus vacío con pin: CPUs permitidas en orden; cpus no vacío implica pin
+    explicit ThreadPool(int threads = 0, bool pin = false, const std::vector<int>& cpus = std::vector<int>());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void spawn(TaskGroup& group, std::function<void()> function);
+    void wait(TaskGroup& group);
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    int size() const;
+    bool pinned() const;
+    void showStats() const;
+
+    // Buffer propio del hilo actual. Se reserva y toca desde ese hilo, así la
+    // política first-touch de Linux lo coloca en su nodo NUMA
+    static unsigned char* localBuffer(size_t size);
+
+    // Interpreta listas como "0-7,16-23"; false si la sintaxis es inválida
+    static bool parseCpuList(const std::string& text, std::vector<int>& cpus);
+};
+
+#endif